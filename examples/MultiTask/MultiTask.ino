@@ -0,0 +1,62 @@
+/*
+  NAME:
+  Demo sketch for displaying from multiple FreeRTOS tasks
+
+  DESCRIPTION:
+  The sketch demonstrates usage of LiquidCrystal_I2C_Queue for ESP32
+  boards, where several tasks update different parts of one LCD.
+  * Each counter task submits its text into the lock-free queue and never
+    waits for the I2C bus.
+  * The drain task is the only one communicating with the LCD.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+    
+  CREDENTIALS:
+  Author: Libor Gabaj
+  Version: 1.0.0
+*/
+#include <Wire.h>
+#include <LiquidCrystal_I2C.h>
+#include <LiquidCrystal_I2C_Queue.h>
+
+// LCD address and geometry for LCD 1602
+const byte lcdAddr = 0x27;  // Typical address of I2C backpack for 1602
+const byte lcdCols = 16;    // Number of characters in a row of display
+const byte lcdRows = 2;     // Number of lines of display
+
+LiquidCrystal_I2C lcd(lcdAddr, lcdCols, lcdRows);
+LiquidCrystal_I2C_Queue<8, lcdCols> lcdQueue(lcd);  // 8 texts of a row width
+
+// Counter task displays its own counter in its own row
+void counterTask(void *parameter) {
+  const byte row = (byte) (uintptr_t) parameter;
+  unsigned int counter = 0;
+  char text[lcdCols + 1];
+  for (;;) {
+    snprintf(text, sizeof(text), "Task %1u: %5u", row, counter++);
+    lcdQueue.print(0, row, text);
+    vTaskDelay(pdMS_TO_TICKS(100 * (row + 1)));
+  }
+}
+
+// Drain task writes submitted texts to the LCD
+void drainTask(void *parameter) {
+  for (;;) {
+    lcdQueue.drain();
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+}
+
+void setup()
+{
+  lcd.init();
+  lcd.backlight();
+  xTaskCreate(drainTask, "drain", 2048, NULL, 2, NULL);
+  for (byte row = 0; row < lcdRows; row++) {
+    xTaskCreate(counterTask, "counter", 2048, (void *) (uintptr_t) row, 1, NULL);
+  }
+}
+
+void loop() {}
@@ -0,0 +1,67 @@
+/*
+  NAME:
+  Arduino.h stand-in for host builds
+
+  DESCRIPTION:
+  Minimal subset of the Arduino core needed for compiling the library on
+  a host computer or by a bare toolchain, e.g., for size reports and tests.
+  - Delays do nothing.
+  - Print mimics the AVR core layout (vtable pointer and write_error).
+*/
+#ifndef ARDUINO_H_HOST_STUB
+#define ARDUINO_H_HOST_STUB
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __AVR__
+  #include <avr/pgmspace.h>
+#else
+  #define PROGMEM
+  #define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+// binary constants used by the library
+#define B00000 0
+#define B00001 1
+#define B00010 2
+#define B00100 4
+#define B01000 8
+#define B10000 16
+#define B11000 24
+#define B11100 28
+#define B11110 30
+#define B11111 31
+#define B00000000 0
+#define B00000001 1
+#define B00000010 2
+#define B00000100 4
+#define B00001000 8
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+
+class Print {
+public:
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char *str) {
+    return write((const uint8_t *) str, strlen(str));
+  }
+  size_t print(const char str[]) {
+    return write(str);
+  }
+private:
+  int write_error;
+};
+
+#endif
@@ -0,0 +1,29 @@
+/*
+  NAME:
+  Wire.h stand-in for host builds
+
+  DESCRIPTION:
+  Every byte written to the I2C bus is passed to the optional hook,
+  so that a test can record the traffic to the LCD.
+*/
+#ifndef WIRE_H_HOST_STUB
+#define WIRE_H_HOST_STUB
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TwoWire {
+public:
+  void begin() {}
+  void beginTransmission(uint8_t addr) { (void) addr; }
+  size_t write(int data) {
+    if (onWrite) onWrite((uint8_t) data);
+    return 1;
+  }
+  uint8_t endTransmission() { return 0; }
+  void (*onWrite)(uint8_t data);
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,46 @@
+/*
+  NAME:
+  LCD traffic recorder for host tests
+
+  DESCRIPTION:
+  Decodes bytes sent to the LCD from nibbles latched by the enable pulse
+  of the I2C traffic recorded by the Wire stand-in.
+  - Commands are stored with the prefix 'C', data with the prefix 'D'.
+  - Every expander write is counted together with its backlight bit.
+*/
+#ifndef LCD_BUS_H
+#define LCD_BUS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "LiquidCrystal_I2C.h"
+
+#define CHECK(cond) do { if (!(cond)) { \
+  printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); exit(1); } } while (0)
+
+static std::string lcdBus;
+static size_t lcdWrites;
+static uint8_t lcdLastWrite;
+static uint8_t lcdNibble;
+static bool lcdHigh = true;
+
+static void lcdRecord(uint8_t data) {
+  lcdWrites++;
+  lcdLastWrite = data;
+  if (!(data & En)) return;
+  if (lcdHigh) {
+    lcdNibble = data & 0xF0;
+  } else {
+    lcdBus += (data & Rs) ? 'D' : 'C';
+    lcdBus += (char) (lcdNibble | (data >> 4));
+  }
+  lcdHigh = !lcdHigh;
+}
+
+static void lcdClear() {
+  lcdBus.clear();
+  lcdWrites = 0;
+}
+
+#endif
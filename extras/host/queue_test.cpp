@@ -0,0 +1,97 @@
+/*
+  NAME:
+  Host test of LiquidCrystal_I2C_Queue
+
+  DESCRIPTION:
+  Decodes the I2C traffic of the LCD recorded by the Wire stand-in and checks
+  - operations of concurrent producers are written complete and in order
+    of their submission by every producer,
+  - full queue rejects operations and accepts them again after draining,
+  - long text is truncated to the text length without splitting a UTF-8
+    character,
+  - each queue instance has its own geometry.
+*/
+#include <thread>
+#include <vector>
+#include "LiquidCrystal_I2C_Queue.h"
+#include "lcd_bus.h"
+
+static void testProducersOrder() {
+  const int producers = 4;
+  const int operations = 2000;
+  LiquidCrystal_I2C lcd(0x27, 20, 4);
+  LiquidCrystal_I2C_Queue<> queue(lcd);
+  lcdClear();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&queue, p] {
+      char text[8];
+      for (int i = 0; i < operations; i++) {
+        snprintf(text, sizeof(text), "%c%04d", 'A' + p, i);
+        while (!queue.print(p, 0, text)) std::this_thread::yield();
+      }
+    });
+  }
+  int drained = 0;
+  while (drained < producers * operations) drained += queue.drain();
+  for (auto &thread : threads) thread.join();
+  CHECK(queue.drain() == 0);
+  // Every operation is a cursor command followed by its 5 characters
+  const size_t operationLen = 2 * (1 + 5);
+  CHECK(lcdBus.size() == operationLen * producers * operations);
+  int next[producers] = {0};
+  for (size_t pos = 0; pos < lcdBus.size(); pos += operationLen) {
+    CHECK(lcdBus[pos] == 'C');
+    int p = (uint8_t) lcdBus[pos + 1] - LCD_SETDDRAMADDR;
+    CHECK(p >= 0 && p < producers);
+    std::string text;
+    for (size_t i = pos + 2; i < pos + operationLen; i += 2) {
+      CHECK(lcdBus[i] == 'D');
+      text += lcdBus[i + 1];
+    }
+    CHECK(text[0] == 'A' + p);
+    CHECK(atoi(text.c_str() + 1) == next[p]++);
+  }
+  for (int p = 0; p < producers; p++) CHECK(next[p] == operations);
+}
+
+template <uint8_t Size, uint8_t TextLen>
+static void testFullQueue() {
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  LiquidCrystal_I2C_Queue<Size, TextLen> queue(lcd);
+  for (int i = 0; i < Size; i++) CHECK(queue.print(0, 0, "x"));
+  CHECK(!queue.print(0, 0, "x"));
+  CHECK(queue.drain() == Size);
+  CHECK(queue.print(0, 0, "x"));
+  CHECK(queue.drain() == 1);
+}
+
+static void testTruncation() {
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  LiquidCrystal_I2C_Queue<4, 6> queue(lcd);
+  lcdClear();
+  CHECK(queue.print(0, 1, "yyyyyyyyy"));
+  CHECK(queue.drain() == 1);
+  CHECK(lcdBus.size() == 2 * (1 + 6));
+  // Two bytes long characters, the fourth one does not fit
+  lcdClear();
+  CHECK(queue.print(0, 1, "y\xC3\xA4\xC3\xB6\xC3\xBC"));
+  CHECK(queue.drain() == 1);
+  CHECK(lcdBus.size() == 2 * (1 + 5));
+  // Three bytes long character just fits
+  lcdClear();
+  CHECK(queue.print(0, 1, "yyy\xE2\x86\x92z"));
+  CHECK(queue.drain() == 1);
+  CHECK(lcdBus.size() == 2 * (1 + 6));
+  CHECK(lcdBus.substr(lcdBus.size() - 6) == "D\xE2" "D\x86" "D\x92");
+}
+
+int main() {
+  Wire.onWrite = lcdRecord;
+  testProducersOrder();
+  testFullQueue<16, 20>();
+  testFullQueue<64, 8>();
+  testTruncation();
+  printf("queue_test: OK\n");
+  return 0;
+}
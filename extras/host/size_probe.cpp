@@ -0,0 +1,5 @@
+// Object size exported as a symbol size, readable by nm even for a target,
+// where the probe cannot be run
+#include "LiquidCrystal_I2C.h"
+
+char lcdi2c_sizeof[sizeof(LiquidCrystal_I2C)];
@@ -0,0 +1,59 @@
+#!/bin/sh
+# Footprint report of the library for every footprint mode
+#
+# Builds the library in each LCDI2C_MODE and prints a markdown table with
+# the object size (sizeof) and section sizes of the compiled library.
+# The AVR toolchain is used if available, the host one otherwise.
+# With the option --update FILE, the table replaces the block between
+# the markers <!-- size-report --> and <!-- /size-report --> in FILE.
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+SRC="$HERE/../../src"
+if command -v avr-g++ >/dev/null 2>&1; then
+  CXX=${CXX:-avr-g++}; SIZE=${SIZE:-avr-size}; NM=${NM:-avr-nm}
+  TARGET="-mmcu=${MCU:-atmega328p}"
+else
+  CXX=${CXX:-g++}; SIZE=${SIZE:-size}; NM=${NM:-nm}
+  TARGET=""
+fi
+CXXFLAGS="$TARGET -Os -std=gnu++11 -ffunction-sections -fdata-sections -DARDUINO=100 -I$HERE -I$SRC"
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+report() {
+  echo "Toolchain: $($CXX --version | head -n 1)${TARGET:+ $TARGET}"
+  echo
+  if [ -z "$TARGET" ]; then
+    echo "**Host build, relative comparison between modes only.** Pointer width, vtables,"
+    echo "and relocations inflate *sizeof* and *.data*, so that the figures are not"
+    echo "the ATmega328 footprint. Regenerate the table with avr-g++ for that."
+    echo
+  fi
+  echo "| Mode    | sizeof | .text | .rodata | .data | .bss |"
+  echo "|---------|-------:|------:|--------:|------:|-----:|"
+  for mode in FULL COMPACT MINIMAL; do
+    flags="$CXXFLAGS -DLCDI2C_MODE=LCDI2C_MODE_$mode"
+    $CXX $flags -c "$SRC/LiquidCrystal_I2C.cpp" -o "$TMP/lib.o"
+    $CXX $flags -c "$HERE/size_probe.cpp" -o "$TMP/probe.o"
+    obj=$($NM -S -t d "$TMP/probe.o" | awk '$4 == "lcdi2c_sizeof" { print $2 + 0 }')
+    # PROGMEM data is in .progmem sections on AVR and in .rodata on host
+    $SIZE -A "$TMP/lib.o" | awk -v mode="$mode" -v obj="$obj" '
+      $1 ~ /^\.text/ { text += $2 }
+      $1 ~ /^\.(rodata|progmem)/ { rodata += $2 }
+      $1 ~ /^\.data/ { data += $2 }
+      $1 ~ /^\.bss/ { bss += $2 }
+      END { printf "| %-7s | %6d | %5d | %7d | %5d | %4d |\n", mode, obj, text, rodata, data, bss }'
+  done
+}
+
+if [ "$1" = "--update" ]; then
+  report > "$TMP/report.md"
+  awk -v report="$TMP/report.md" '
+    /<!-- \/size-report -->/ { skip = 0 }
+    !skip { print }
+    /<!-- size-report -->/ { while ((getline line < report) > 0) print line; skip = 1 }
+  ' "$2" > "$TMP/updated"
+  cat "$TMP/updated" > "$2"
+else
+  report
+fi
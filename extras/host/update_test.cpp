@@ -0,0 +1,91 @@
+/*
+  NAME:
+  Host test of beginUpdate() and endUpdate()
+
+  DESCRIPTION:
+  Checks on the I2C traffic recorded by the Wire stand-in that
+  - changes in a transaction are merged into one command per register,
+  - unchanged registers and backlight are not sent at all,
+  - changed entry mode is sent before text written in the transaction,
+  - backlight is not sent extra, if a write in the transaction carried it.
+*/
+#include "lcd_bus.h"
+
+// Expected command or data on the bus
+static std::string cmd(uint8_t value) { return std::string("C") + (char) value; }
+static std::string data(uint8_t value) { return std::string("D") + (char) value; }
+
+static void testMergedCommands() {
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  lcd.init();
+  lcdClear();
+  lcd.beginUpdate();
+  lcd.cursor();
+  lcd.blink();
+  lcd.backlight();
+  lcd.endUpdate();
+  CHECK(lcdBus == cmd(LCD_DISPLAYCONTROL | LCD_DISPLAYON | LCD_CURSORON | LCD_BLINKON));
+  CHECK(lcdLastWrite & LCD_BACKLIGHT);
+}
+
+static void testUnchanged() {
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  lcd.init();
+  lcdClear();
+  lcd.beginUpdate();
+  lcd.cursor();
+  lcd.noCursor();
+  lcd.noBacklight();
+  lcd.beginUpdate();
+  lcd.autoscroll();
+  lcd.noAutoscroll();
+  lcd.endUpdate();
+  lcd.endUpdate();
+  CHECK(lcdWrites == 0);
+}
+
+static void testEntryModeBeforeText() {
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  lcd.init();
+  lcdClear();
+  lcd.beginUpdate();
+  lcd.rightToLeft();
+  lcd.print("ab");
+  lcd.endUpdate();
+  CHECK(lcdBus == cmd(LCD_ENTRYMODESET) + data('a') + data('b'));
+  lcdClear();
+  lcd.beginUpdate();
+  lcd.autoscroll();
+  lcd.setCursor(3, 1);
+  lcd.endUpdate();
+  CHECK(lcdBus == cmd(LCD_ENTRYMODESET | LCD_ENTRYSHIFTINCREMENT) + cmd(LCD_SETDDRAMADDR | 0x43));
+}
+
+static void testBacklightCarried() {
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  lcd.init();
+  lcdClear();
+  lcd.beginUpdate();
+  lcd.backlight();
+  lcd.write('x');
+  lcd.endUpdate();
+  CHECK(lcdBus == data('x'));
+  CHECK(lcdWrites == 6);
+  CHECK(lcdLastWrite & LCD_BACKLIGHT);
+  lcdClear();
+  lcd.beginUpdate();
+  lcd.noBacklight();
+  lcd.endUpdate();
+  CHECK(lcdWrites == 1);
+  CHECK(!(lcdLastWrite & LCD_BACKLIGHT));
+}
+
+int main() {
+  Wire.onWrite = lcdRecord;
+  testMergedCommands();
+  testUnchanged();
+  testEntryModeBeforeText();
+  testBacklightCarried();
+  printf("update_test: OK\n");
+  return 0;
+}
@@ -0,0 +1,86 @@
+/*
+  NAME:
+  Host test of UTF-8 transcoding
+
+  DESCRIPTION:
+  Checks on the I2C traffic recorded by the Wire stand-in that
+  - characters are transcoded to the A00 character ROM,
+  - invalid and not displayable sequences are replaced,
+  - backslash and tilde are replaced or displayed by custom characters,
+  - custom characters take precedence over the ROM until overwritten.
+*/
+#include "lcd_bus.h"
+
+// Codes written to the display RAM for the text
+static std::string display(LiquidCrystal_I2C &lcd, const char *text) {
+  lcdClear();
+  lcd.print(text);
+  std::string codes;
+  for (size_t i = 0; i < lcdBus.size(); i += 2) {
+    CHECK(lcdBus[i] == 'D');
+    codes += lcdBus[i + 1];
+  }
+  return codes;
+}
+
+static void testRom(LiquidCrystal_I2C &lcd) {
+  // Latin-1
+  CHECK(display(lcd, "25\xC2\xB0" "C") == "25\xDF" "C");
+  CHECK(display(lcd, "\xC3\xA4\xC3\xB6\xC3\xBC\xC3\x9F") == "\xE1\xEF\xF5\xE2");
+  // Greek
+  CHECK(display(lcd, "\xCE\xB1\xCE\xB2\xCE\xA9\xCF\x80") == "\xE0\xE2\xF4\xF7");
+  // Half-width katakana and symbols
+  CHECK(display(lcd, "\xEF\xBD\xB1\xEF\xBE\x9F") == "\xB1\xDF");
+  CHECK(display(lcd, "\xE2\x86\x92\xE5\x86\x86") == "\x7E\xFC");
+  // Missing in the ROM
+  CHECK(display(lcd, "\xC3\x85") == "?");
+}
+
+static void testInvalid(LiquidCrystal_I2C &lcd) {
+  // Overlong encoding of '/' and of NUL
+  CHECK(display(lcd, "\xC0\xAF" "a") == "?a");
+  CHECK(display(lcd, "\xC0\x80") == "?");
+  // 4 bytes long sequence is beyond the ROM
+  CHECK(display(lcd, "\xF0\x9F\x98\x80" "b") == "?b");
+  // Stray continuation bytes, interrupted sequences, and non UTF-8 bytes
+  CHECK(display(lcd, "\x80\xBF" "z") == "??z");
+  CHECK(display(lcd, "\xE4" "x") == "?x");
+  CHECK(display(lcd, "\xE2\x86\xC2\xB0") == "?\xDF");
+  CHECK(display(lcd, "\xFF" "c") == "?c");
+}
+
+static void testBackslashTilde(LiquidCrystal_I2C &lcd) {
+  CHECK(display(lcd, "a\\b~") == "a?b?");
+  uint8_t glyph[8] = {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00};
+  lcd.createUtf8Char(6, '\\', glyph);
+  CHECK(display(lcd, "\\~") == "\x06?");
+  lcd.noUtf8();
+  CHECK(display(lcd, "\\~") == "\\~");
+  lcd.utf8();
+}
+
+static void testCustomChars(LiquidCrystal_I2C &lcd) {
+  uint8_t glyph[8] = {0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00};
+  // Registered character takes precedence over the ROM
+  lcd.createUtf8Char(3, 0x00E4, glyph);
+  lcd.createUtf8Char(4, 0x00C5, glyph);
+  CHECK(display(lcd, "\xC3\xA4\xC3\x85") == std::string("\x03\x04", 2));
+  // Registration is lost by overwriting the location
+  lcd.createChar(3, glyph);
+  CHECK(display(lcd, "\xC3\xA4\xC3\x85") == "\xE1\x04");
+  lcd.init_bargraph(LCDI2C_HORIZONTAL_BAR_GRAPH);
+  CHECK(display(lcd, "\xC3\x85") == "?");
+}
+
+int main() {
+  Wire.onWrite = lcdRecord;
+  LiquidCrystal_I2C lcd(0x27, 16, 2);
+  lcd.init();
+  lcd.utf8();
+  testRom(lcd);
+  testInvalid(lcd);
+  testBackslashTilde(lcd);
+  testCustomChars(lcd);
+  printf("utf8_test: OK\n");
+  return 0;
+}
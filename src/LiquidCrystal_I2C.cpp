@@ -18,12 +18,22 @@
 // Note, however, that resetting the Arduino doesn't reset the LCD, so we
 // can't assume that its in that state when a sketch starts (and the
 // LiquidCrystal constructor is called).
-LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows)
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows, LCDI2C_LAYOUT)
 {
   _Addr = addr;
   _cols = cols;
   _rows = rows;
   _backlightval = LCD_NOBACKLIGHT;
+  _update = 0;
+  _sentbacklightval = _backlightval;
+#if LCDI2C_GRAPHS
+  _graphtype = 0;
+#endif
+#if LCDI2C_UTF8
+  _utf8 = false;
+  _utf8pending = 0;
+  for (uint8_t i = 0; i < 8; i++) _utf8cgram[i] = 0;
+#endif
 }
 
 void LiquidCrystal_I2C::init(){
@@ -80,6 +90,9 @@ void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t lines, uint8_t charsize) {
 	// set # lines, font size, etc.
 	command(LCD_FUNCTIONSET | _displayfunction);  
 	
+	// commands below have to be sent immediately
+	_update = 0;
+
 	// turn the display on with no cursor or blinking default
 	_displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
 	display();
@@ -135,31 +148,31 @@ void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row){
 // Turn the display on/off (quickly)
 void LiquidCrystal_I2C::noDisplay() {
 	_displaycontrol &= ~LCD_DISPLAYON;
-	command(LCD_DISPLAYCONTROL | _displaycontrol);
+	updateDisplayControl();
 }
 void LiquidCrystal_I2C::display() {
 	_displaycontrol |= LCD_DISPLAYON;
-	command(LCD_DISPLAYCONTROL | _displaycontrol);
+	updateDisplayControl();
 }
 
 // Turns the underline cursor on/off
 void LiquidCrystal_I2C::noCursor() {
 	_displaycontrol &= ~LCD_CURSORON;
-	command(LCD_DISPLAYCONTROL | _displaycontrol);
+	updateDisplayControl();
 }
 void LiquidCrystal_I2C::cursor() {
 	_displaycontrol |= LCD_CURSORON;
-	command(LCD_DISPLAYCONTROL | _displaycontrol);
+	updateDisplayControl();
 }
 
 // Turn on and off the blinking cursor
 void LiquidCrystal_I2C::noBlink() {
 	_displaycontrol &= ~LCD_BLINKON;
-	command(LCD_DISPLAYCONTROL | _displaycontrol);
+	updateDisplayControl();
 }
 void LiquidCrystal_I2C::blink() {
 	_displaycontrol |= LCD_BLINKON;
-	command(LCD_DISPLAYCONTROL | _displaycontrol);
+	updateDisplayControl();
 }
 
 // These commands scroll the display without changing the RAM
@@ -173,25 +186,25 @@ void LiquidCrystal_I2C::scrollDisplayRight(void) {
 // This is for text that flows Left to Right
 void LiquidCrystal_I2C::leftToRight(void) {
 	_displaymode |= LCD_ENTRYLEFT;
-	command(LCD_ENTRYMODESET | _displaymode);
+	updateEntryMode();
 }
 
 // This is for text that flows Right to Left
 void LiquidCrystal_I2C::rightToLeft(void) {
 	_displaymode &= ~LCD_ENTRYLEFT;
-	command(LCD_ENTRYMODESET | _displaymode);
+	updateEntryMode();
 }
 
 // This will 'right justify' text from the cursor
 void LiquidCrystal_I2C::autoscroll(void) {
 	_displaymode |= LCD_ENTRYSHIFTINCREMENT;
-	command(LCD_ENTRYMODESET | _displaymode);
+	updateEntryMode();
 }
 
 // This will 'left justify' text from the cursor
 void LiquidCrystal_I2C::noAutoscroll(void) {
 	_displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
-	command(LCD_ENTRYMODESET | _displaymode);
+	updateEntryMode();
 }
 
 // Allows us to fill the first 8 CGRAM locations
@@ -200,21 +213,56 @@ void LiquidCrystal_I2C::createChar(uint8_t location, uint8_t charmap[]) {
 	location &= 0x7; // we only have 8 locations 0-7
 	command(LCD_SETCGRAMADDR | (location << 3));
 	for (int i=0; i<8; i++) {
-		write(charmap[i]);
+		send(charmap[i], Rs);	// bypass transcoding of write()
 	}
+#if LCDI2C_UTF8
+	_utf8cgram[location] = 0;
+#endif
 }
 
 // Turn the (optional) backlight off/on
 void LiquidCrystal_I2C::noBacklight(void) {
 	_backlightval=LCD_NOBACKLIGHT;
-	expanderWrite(0);
+	updateBacklight();
 }
 
 void LiquidCrystal_I2C::backlight(void) {
 	_backlightval=LCD_BACKLIGHT;
-	expanderWrite(0);
+	updateBacklight();
+}
+
+
+// Merge changes of display control, entry mode, and backlight
+void LiquidCrystal_I2C::beginUpdate() {
+	if (_update++) return;
+	_updatedisplaycontrol = _displaycontrol;
+	_updatedisplaymode = _displaymode;
+}
+
+void LiquidCrystal_I2C::endUpdate() {
+	if (!_update || --_update) return;
+	if (_displaycontrol != _updatedisplaycontrol) {
+		command(LCD_DISPLAYCONTROL | _displaycontrol);
+	}
+	if (_displaymode != _updatedisplaymode) {
+		command(LCD_ENTRYMODESET | _displaymode);
+	}
+	// Every expander write carries the backlight bit already
+	if (_backlightval != _sentbacklightval) {
+		expanderWrite(0);
+	}
 }
 
+// Send register changes unless they are merged by a transaction
+void LiquidCrystal_I2C::updateDisplayControl() {
+	if (!_update) command(LCD_DISPLAYCONTROL | _displaycontrol);
+}
+void LiquidCrystal_I2C::updateEntryMode() {
+	if (!_update) command(LCD_ENTRYMODESET | _displaymode);
+}
+void LiquidCrystal_I2C::updateBacklight() {
+	if (!_update) expanderWrite(0);
+}
 
 
 /*********** mid level commands, for sending data/cmds */
@@ -224,16 +272,137 @@ inline void LiquidCrystal_I2C::command(uint8_t value) {
 }
 
 inline size_t LiquidCrystal_I2C::write(uint8_t value) {
+#if LCDI2C_UTF8
+	if (_utf8) {
+		// Sequence interrupted by other than a continuation byte
+		if (_utf8pending && (value & 0xC0) != 0x80) {
+			_utf8pending = 0;
+			send(LCDI2C_UTF8_REPLACEMENT, Rs);
+		}
+		if ((value & 0xC0) == 0x80) {
+			// Continuation byte, stray one is invalid
+			if (!_utf8pending) {
+				value = LCDI2C_UTF8_REPLACEMENT;
+			} else {
+				// Code points above 0xFFFF are not displayable
+				_utf8code = _utf8code > 0x3FF ? 0xFFFF : (_utf8code << 6) | (value & 0x3F);
+				if (--_utf8pending) return 1;
+				// Overlong encoding of ASCII is not valid UTF-8
+				value = _utf8code < 0x80 ? LCDI2C_UTF8_REPLACEMENT : utf8Rom(_utf8code);
+			}
+		} else if (value >= 0xF8) {
+			value = LCDI2C_UTF8_REPLACEMENT;	// Not a UTF-8 byte
+		} else if (value >= 0xC0) {
+			// Lead byte of 2, 3, or 4 bytes long sequence
+			_utf8pending = (value >= 0xF0) ? 3 : (value >= 0xE0) ? 2 : 1;
+			_utf8code = value & (0x3F >> _utf8pending);
+			return 1;
+		} else if (value == '\\' || value == '~') {
+			// ROM has ¥ and → at positions of backslash and tilde
+			value = utf8Rom(value);
+		}
+	}
+#endif
 	send(value, Rs);
 	return 1; // Number of processed bytes
 }
 
 
 
+#if LCDI2C_UTF8
+/*********** UTF-8 transcoding to the A00 character ROM */
+
+// ROM codes for Latin-1 characters U+00A0 - U+00FF, 0 if missing
+static const uint8_t utf8Latin1Rom[0x60] PROGMEM = {
+  0x20, 0x00, 0xEC, 0xED, 0x00, 0x5C, 0x00, 0x00,  // U+00A0 nbsp ¢ £ ¥
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xDF, 0x00, 0x00, 0x00, 0x00, 0xE4, 0x00, 0xA5,  // U+00B0 ° µ ·
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // U+00C0
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // U+00D0 ß
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE2,
+  0x00, 0x00, 0x00, 0x00, 0xE1, 0x00, 0x00, 0x00,  // U+00E0 ä
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0xEE, 0x00, 0x00, 0x00, 0x00, 0xEF, 0xFD,  // U+00F0 ñ ö ÷ ü
+  0x00, 0x00, 0x00, 0x00, 0xF5, 0x00, 0x00, 0x00,
+};
+
+// ROM codes for Greek characters U+0390 - U+03CF, 0 if missing
+static const uint8_t utf8GreekRom[0x40] PROGMEM = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // U+0390
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0xF6, 0x00, 0x00, 0x00, 0x00,  // U+03A0 Σ Ω
+  0x00, 0xF4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0xE0, 0xE2, 0x00, 0x00, 0xE3, 0x00, 0x00,  // U+03B0 α β ε θ μ
+  0xF2, 0x00, 0x00, 0x00, 0xE4, 0x00, 0x00, 0x00,
+  0xF7, 0xE6, 0x00, 0xE5, 0x00, 0x00, 0x00, 0x00,  // U+03C0 π ρ σ
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+// Turn transcoding of UTF-8 text on/off
+void LiquidCrystal_I2C::utf8() {
+	_utf8 = true;
+	_utf8pending = 0;
+}
+void LiquidCrystal_I2C::noUtf8() {
+	_utf8 = false;
+}
+
+// Create custom character for a UTF-8 character missing in the ROM
+void LiquidCrystal_I2C::createUtf8Char(uint8_t location, uint16_t unicode, uint8_t charmap[]) {
+	createChar(location, charmap);
+	_utf8cgram[location & 0x7] = unicode;
+}
+
+// ROM or CGRAM code for a Unicode code point
+uint8_t LiquidCrystal_I2C::utf8Rom(uint16_t unicode) {
+	uint8_t rom = 0;
+	// Custom characters take precedence over the ROM
+	for (uint8_t i = 0; i < 8; i++) {
+		if (_utf8cgram[i] == unicode) return i;
+	}
+	if (unicode >= 0x00A0 && unicode <= 0x00FF) {
+		rom = pgm_read_byte(&utf8Latin1Rom[unicode - 0x00A0]);
+	} else if (unicode >= 0x0390 && unicode <= 0x03CF) {
+		rom = pgm_read_byte(&utf8GreekRom[unicode - 0x0390]);
+	} else if (unicode >= 0xFF61 && unicode <= 0xFF9F) {
+		rom = unicode - 0xFF61 + 0xA1;	// Half-width katakana in ROM order
+	} else {
+		switch (unicode) {
+			case 0x2126: rom = 0xF4; break;	// Ω ohm sign
+			case 0x2190: rom = 0x7F; break;	// ←
+			case 0x2192: rom = 0x7E; break;	// →
+			case 0x221A: rom = 0xE8; break;	// √
+			case 0x221E: rom = 0xF3; break;	// ∞
+			case 0x2588: rom = 0xFF; break;	// █
+			case 0x3001: rom = 0xA4; break;	// 、
+			case 0x3002: rom = 0xA1; break;	// 。
+			case 0x300C: rom = 0xA2; break;	// 「
+			case 0x300D: rom = 0xA3; break;	// 」
+			case 0x30FB: rom = 0xA5; break;	// ・
+			case 0x30FC: rom = 0xB0; break;	// ー
+			case 0x4E07: rom = 0xFB; break;	// 万
+			case 0x5186: rom = 0xFC; break;	// 円
+			case 0x5343: rom = 0xFA; break;	// 千
+		}
+	}
+	return rom ? rom : LCDI2C_UTF8_REPLACEMENT;
+}
+#endif
+
+
+
 /************ low level data pushing commands **********/
 
 // write either command or data
 void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode) {
+	// Entry mode changed in a transaction applies to text written in it
+	if (_update && _displaymode != _updatedisplaymode
+		&& ((mode & Rs) || (value & LCD_SETDDRAMADDR))) {
+		_updatedisplaymode = _displaymode;
+		command(LCD_ENTRYMODESET | _displaymode);
+	}
 	uint8_t highnib = value & 0xF0;
 	uint8_t lownib = value << 4;
 	write4bits((highnib)|mode);
@@ -248,6 +417,7 @@ void LiquidCrystal_I2C::write4bits(uint8_t value) {
 void LiquidCrystal_I2C::expanderWrite(uint8_t _data){                                        
 	Wire.beginTransmission(_Addr);
 	Wire.write((int)(_data) | _backlightval);
+	_sentbacklightval = _backlightval;
 	Wire.endTransmission();   
 }
 
@@ -259,49 +429,72 @@ void LiquidCrystal_I2C::pulseEnable(uint8_t _data){
 	delayMicroseconds(50);		// commands need > 37us to settle
 } 
 
-// Create custom characters for horizontal graphs
-uint8_t LiquidCrystal_I2C::graphHorizontalChars(uint8_t rowPattern) {
-  uint8_t cc[LCD_CHARACTER_VERTICAL_DOTS];
-  for (uint8_t idxCol = 0; idxCol < LCD_CHARACTER_HORIZONTAL_DOTS; idxCol++) {
-    for (uint8_t idxRow = 0; idxRow < LCD_CHARACTER_VERTICAL_DOTS; idxRow++) {
-      cc[idxRow] = rowPattern << (LCD_CHARACTER_HORIZONTAL_DOTS - 1 - idxCol);
-    }
-    createChar(idxCol, cc);
-  }
-  return LCD_CHARACTER_HORIZONTAL_DOTS;
-}
-
-// Create custom characters for vertical graphs
-uint8_t LiquidCrystal_I2C::graphVerticalChars(uint8_t rowPattern) {
+#if LCDI2C_GRAPHS
+static_assert(LCDI2C_GRAPH_STATE_SIZE >= 4,
+  "LCDI2C_GRAPH_STATE_SIZE must cover at least 4 rows");
+
+// Predefined graph glyphs with row patterns from the top of a character
+static const uint8_t graphHorizontalBarGlyphs[LCD_CHARACTER_HORIZONTAL_DOTS][LCD_CHARACTER_VERTICAL_DOTS] PROGMEM = {
+  {B10000, B10000, B10000, B10000, B10000, B10000, B10000, B10000},
+  {B11000, B11000, B11000, B11000, B11000, B11000, B11000, B11000},
+  {B11100, B11100, B11100, B11100, B11100, B11100, B11100, B11100},
+  {B11110, B11110, B11110, B11110, B11110, B11110, B11110, B11110},
+  {B11111, B11111, B11111, B11111, B11111, B11111, B11111, B11111},
+};
+static const uint8_t graphHorizontalLineGlyphs[LCD_CHARACTER_HORIZONTAL_DOTS][LCD_CHARACTER_VERTICAL_DOTS] PROGMEM = {
+  {B10000, B10000, B10000, B10000, B10000, B10000, B10000, B10000},
+  {B01000, B01000, B01000, B01000, B01000, B01000, B01000, B01000},
+  {B00100, B00100, B00100, B00100, B00100, B00100, B00100, B00100},
+  {B00010, B00010, B00010, B00010, B00010, B00010, B00010, B00010},
+  {B00001, B00001, B00001, B00001, B00001, B00001, B00001, B00001},
+};
+static const uint8_t graphVerticalBarGlyphs[LCD_CHARACTER_VERTICAL_DOTS][LCD_CHARACTER_VERTICAL_DOTS] PROGMEM = {
+  {B00000, B00000, B00000, B00000, B00000, B00000, B00000, B11111},
+  {B00000, B00000, B00000, B00000, B00000, B00000, B11111, B11111},
+  {B00000, B00000, B00000, B00000, B00000, B11111, B11111, B11111},
+  {B00000, B00000, B00000, B00000, B11111, B11111, B11111, B11111},
+  {B00000, B00000, B00000, B11111, B11111, B11111, B11111, B11111},
+  {B00000, B00000, B11111, B11111, B11111, B11111, B11111, B11111},
+  {B00000, B11111, B11111, B11111, B11111, B11111, B11111, B11111},
+  {B11111, B11111, B11111, B11111, B11111, B11111, B11111, B11111},
+};
+
+// Create custom characters for graphs from a predefined glyph set
+uint8_t LiquidCrystal_I2C::graphChars(const uint8_t *glyphs, uint8_t count) {
   uint8_t cc[LCD_CHARACTER_VERTICAL_DOTS];
-  for (uint8_t idxChr = 0; idxChr < LCD_CHARACTER_VERTICAL_DOTS; idxChr++) {
+  for (uint8_t idxChr = 0; idxChr < count; idxChr++) {
     for (uint8_t idxRow = 0; idxRow < LCD_CHARACTER_VERTICAL_DOTS; idxRow++) {
-      cc[LCD_CHARACTER_VERTICAL_DOTS - idxRow - 1] = idxRow > idxChr ? B00000 : rowPattern;
+      cc[idxRow] = pgm_read_byte(glyphs++);
     }
     createChar(idxChr, cc);
   }
-  return LCD_CHARACTER_VERTICAL_DOTS;
+  return count;
 }
 
 // Initializes custom characters for input graph type
 uint8_t LiquidCrystal_I2C::init_bargraph(uint8_t graphtype) {
+  // Graph state has to cover all rows and for vertical graphs all columns
+  if (_rows > LCDI2C_GRAPH_STATE_SIZE
+    || (graphtype == LCDI2C_VERTICAL_BAR_GRAPH && _cols > LCDI2C_GRAPH_STATE_SIZE)) {
+    return 1;
+  }
   // Initialize row state vector
   for(byte i = 0; i < _rows; i++) {
     _graphstate[i] = 255;
   }
 	switch (graphtype) {
 		case LCDI2C_VERTICAL_BAR_GRAPH:
-      graphVerticalChars(B11111);
+      graphChars(&graphVerticalBarGlyphs[0][0], LCD_CHARACTER_VERTICAL_DOTS);
       // Initialize column state vector
       for(byte i = _rows; i < _cols; i++) {
         _graphstate[i] = 255;
       }
 			break;
 		case LCDI2C_HORIZONTAL_BAR_GRAPH:
-      graphHorizontalChars(B11111);
+      graphChars(&graphHorizontalBarGlyphs[0][0], LCD_CHARACTER_HORIZONTAL_DOTS);
 			break;
 		case LCDI2C_HORIZONTAL_LINE_GRAPH:
-      graphHorizontalChars(B00001);
+      graphChars(&graphHorizontalLineGlyphs[0][0], LCD_CHARACTER_HORIZONTAL_DOTS);
 			break;
 		default:
 			return 1;
@@ -317,6 +510,8 @@ void LiquidCrystal_I2C::draw_horizontal_graph(uint8_t row, uint8_t column, uint8
   column = constrain(column, 0, _cols - 1);
   len = constrain(len, 0, _cols - column);
   pixel_col_end = constrain(pixel_col_end, 0, (len * LCD_CHARACTER_HORIZONTAL_DOTS) - 1);
+  // Graph state is valid for initialized graph only
+  if (_graphtype != LCDI2C_HORIZONTAL_BAR_GRAPH && _graphtype != LCDI2C_HORIZONTAL_LINE_GRAPH) return;
   _graphstate[row] = constrain(_graphstate[row], column, column + len - 1);
   // Display graph
   switch (_graphtype) {
@@ -358,6 +553,8 @@ void LiquidCrystal_I2C::draw_vertical_graph(uint8_t row, uint8_t column, uint8_t
   column = constrain(column, 0, _cols - 1);
   len = constrain(len, 0, row + 1);
   pixel_row_end = constrain(pixel_row_end, 0, (len * LCD_CHARACTER_VERTICAL_DOTS) - 1);
+  // Graph state is valid for initialized graph only
+  if (_graphtype != LCDI2C_VERTICAL_BAR_GRAPH) return;
   _graphstate[column] = constrain(_graphstate[column], row - len + 1, row);
   // Display graph
 	switch (_graphtype) {
@@ -386,18 +583,21 @@ void LiquidCrystal_I2C::draw_horizontal_graph(uint8_t row, uint8_t column, uint8
   percentage = (percentage * len * LCD_CHARACTER_HORIZONTAL_DOTS / 100) - 1;
   draw_horizontal_graph(row, column, len, (uint8_t) percentage);
 }
-void LiquidCrystal_I2C::draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len, float ratio) {
-  ratio = (ratio * len * LCD_CHARACTER_HORIZONTAL_DOTS) - 1;
-  draw_horizontal_graph(row, column, len, (uint8_t) ratio);
-}
 void LiquidCrystal_I2C::draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint16_t percentage) {
   percentage = (percentage * len * LCD_CHARACTER_VERTICAL_DOTS / 100) - 1;
   draw_vertical_graph(row, column, len, (uint8_t) percentage);
 }
+#if LCDI2C_GRAPHS_FLOAT
+void LiquidCrystal_I2C::draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len, float ratio) {
+  ratio = (ratio * len * LCD_CHARACTER_HORIZONTAL_DOTS) - 1;
+  draw_horizontal_graph(row, column, len, (uint8_t) ratio);
+}
 void LiquidCrystal_I2C::draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  float ratio) {
   ratio = (ratio * len * LCD_CHARACTER_VERTICAL_DOTS) - 1;
   draw_vertical_graph(row, column, len, (uint8_t) ratio);
 }
+#endif
+#endif
 
 // Alias functions
 
@@ -32,13 +32,14 @@
 #define LIQUIDCRYSTAL_I2C_H
 #define LIQUIDCRYSTAL_I2C_VERSION "LiquidCrystal_I2C 2.6.1"
 
-#ifdef ARDUINO_ARCH_AVR
+#ifdef ARDUINO
   #if ARDUINO >= 100
     #include "Arduino.h"
   #else
     #include "WProgram.h"
   #endif
   #include <inttypes.h>
+  #include <Wire.h>
 #endif
 
 // commands
@@ -90,13 +91,60 @@
 #define LCD_CHARACTER_HORIZONTAL_DOTS 5
 #define LCD_CHARACTER_VERTICAL_DOTS   8
 
+// footprint modes for compile-time stripping of features
+// The Arduino IDE compiles the library separately from a sketch, so that
+// a mode has to be set by a build flag, e.g., -DLCDI2C_MODE=2, or here.
+#define LCDI2C_MODE_FULL    0  // all features
+#define LCDI2C_MODE_COMPACT 1  // graphs without float overloads, no UTF-8
+#define LCDI2C_MODE_MINIMAL 2  // no graphs at all
+#ifndef LCDI2C_MODE
+  #define LCDI2C_MODE LCDI2C_MODE_FULL
+#endif
+#ifndef LCDI2C_GRAPHS
+  #define LCDI2C_GRAPHS (LCDI2C_MODE < LCDI2C_MODE_MINIMAL)
+#endif
+#ifndef LCDI2C_GRAPHS_FLOAT
+  #define LCDI2C_GRAPHS_FLOAT (LCDI2C_GRAPHS && LCDI2C_MODE < LCDI2C_MODE_COMPACT)
+#endif
+#ifndef LCDI2C_UTF8
+  #define LCDI2C_UTF8 (LCDI2C_MODE == LCDI2C_MODE_FULL)
+#endif
+// graph state is kept per row or column, so that the widest display counts
+#ifndef LCDI2C_GRAPH_STATE_SIZE
+  #define LCDI2C_GRAPH_STATE_SIZE 20
+#endif
+// ROM code displayed for UTF-8 characters without a ROM or CGRAM glyph
+#ifndef LCDI2C_UTF8_REPLACEMENT
+  #define LCDI2C_UTF8_REPLACEMENT '?'
+#endif
+
+// layout guard for features changing the object layout
+// The constructor is declared with a tag type named after those features,
+// so that a sketch compiled with other features than the library fails to
+// link instead of corrupting memory. LCDI2C_GRAPH_STATE_SIZE has to be
+// a plain decimal number therefore.
+#if LCDI2C_GRAPHS
+  #define LCDI2C_LAYOUT_GRAPHS LCDI2C_GRAPH_STATE_SIZE
+#else
+  #define LCDI2C_LAYOUT_GRAPHS 0
+#endif
+#if LCDI2C_UTF8
+  #define LCDI2C_LAYOUT_UTF8 1
+#else
+  #define LCDI2C_LAYOUT_UTF8 0
+#endif
+#define LCDI2C_LAYOUT_NAME_(graphs, utf8) lcdi2c_layout_graphs##graphs##_utf8##utf8
+#define LCDI2C_LAYOUT_NAME(graphs, utf8) LCDI2C_LAYOUT_NAME_(graphs, utf8)
+#define LCDI2C_LAYOUT LCDI2C_LAYOUT_NAME(LCDI2C_LAYOUT_GRAPHS, LCDI2C_LAYOUT_UTF8)
+struct LCDI2C_LAYOUT {};
+
 #define En B00000100  // Enable bit
 #define Rw B00000010  // Read/Write bit
 #define Rs B00000001  // Register select bit
 
 class LiquidCrystal_I2C : public Print {
 public:
-  LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows);
+  LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows, LCDI2C_LAYOUT layout = LCDI2C_LAYOUT());
   void begin(uint8_t cols, uint8_t rows, uint8_t charsize = LCD_5x8DOTS);
   void init();
 /*
@@ -137,11 +185,74 @@ public:
   void backlight();
   void noAutoscroll(); 
   void autoscroll();
+/*
+  Merge changes of display control, entry mode, and backlight
+  
+  DESCRIPTION:
+  Functions between beginUpdate() and endUpdate() just change internal
+  state of the display control (display, cursor, blink), entry mode (text
+  direction, autoscroll), and backlight.
+  * The endUpdate() sends at most one command per register and none if the
+    register value has not changed since beginUpdate().
+  * A changed entry mode is sent before the first text write or cursor
+    positioning in the transaction, so that the text follows it.
+  * The backlight is sent by an extra expander write only if nothing has
+    been written since its change, because each write carries its bit.
+  * Transactions can be nested, changes are sent by the outermost one.
+  
+  RETURN:	none
+*/
+  void beginUpdate();
+  void endUpdate();
   void createChar(uint8_t location, uint8_t charmap[]);
   void setCursor(uint8_t col, uint8_t row); 
   virtual size_t write(uint8_t value);
   void command(uint8_t value);
 
+#if LCDI2C_UTF8
+/*
+  Turn transcoding of UTF-8 text to the LCD's character ROM on/off
+  
+  DESCRIPTION:
+  When turned on, write() and so print() decode UTF-8 sequences byte by
+  byte and display each character with its ROM code of the A00 character
+  set (ASCII, Latin-1 symbols, Greek letters, half-width katakana).
+  * Characters missing in the ROM are displayed with custom characters
+    registered by createUtf8Char(), otherwise as LCDI2C_UTF8_REPLACEMENT.
+    It applies to backslash and tilde as well, because the ROM has ¥ and →
+    at their positions.
+  * Invalid sequences, e.g., overlong encoding of ASCII, stray continuation
+    bytes, or a sequence interrupted by another character, are displayed
+    as LCDI2C_UTF8_REPLACEMENT. An unfinished sequence at the end of a text
+    is displayed so when the next character is written.
+  * When turned off (default), bytes are written to the LCD unchanged.
+  
+  RETURN:	none
+*/
+  void utf8();
+  void noUtf8();
+
+/*
+  Create custom character for a UTF-8 character missing in the ROM
+  
+  DESCRIPTION:
+  Creates custom character like createChar() and registers it for the
+  input Unicode code point, so that the transcoding displays it.
+  The registration is dropped when the location is overwritten by another
+  custom character, e.g., by graph initialization.
+  
+  PARAMETERS:
+  uint8_t location  - position of the custom character in CGRAM (0 - 7)
+  uint16_t unicode  - Unicode code point of the character, e.g., 0x00C4 for Ä
+                      Limited to 0x0080 - 0xFFFF, backslash, and tilde.
+  uint8_t charmap[] - character row patterns from the top of the char
+  
+  RETURN:	none
+*/
+  void createUtf8Char(uint8_t location, uint16_t unicode, uint8_t charmap[]);
+#endif
+
+#if LCDI2C_GRAPHS
 /*
   Initialize particular bar graph
   
@@ -158,7 +269,8 @@ public:
 
   RETURN:	error code
           0 - at success
-          1 - at failure, e.g., graph type not recognized
+          1 - at failure, e.g., graph type not recognized, or rows or
+              columns (vertical graph) exceed LCDI2C_GRAPH_STATE_SIZE
 */
 uint8_t init_bargraph(uint8_t graphtype);
 
@@ -228,9 +340,12 @@ void draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixe
     Expected range is 0.0 to 1.0
 */
 void draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len, uint16_t percentage);
-void draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len, float ratio);
 void draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint16_t percentage);
+#if LCDI2C_GRAPHS_FLOAT
+void draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len, float ratio);
 void draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  float ratio);
+#endif
+#endif
 
 ////compatibility API function aliases
 void on();                          // alias for display()
@@ -256,38 +371,31 @@ private:
   void write4bits(uint8_t);
   void expanderWrite(uint8_t);
   void pulseEnable(uint8_t);
+  void updateDisplayControl();
+  void updateEntryMode();
+  void updateBacklight();
+#if LCDI2C_UTF8
+  uint8_t utf8Rom(uint16_t unicode);
+#endif
 
+#if LCDI2C_GRAPHS
 /*
-  Create custom characters for horizontal graphs
-  
-  DESCRIPTION:
-  Creates the set of custom characters for displaying horizontal graphs.
-  The first 5 current custom characters will be overwritten.
-  Particular custom characters are filled by bit shifting fullCharRowPattern
-  from the right to the left.
-  
-  PARAMETERS:
-  uint8_t rowPattern - row pattern of the full character
-
-  RETURN:	uint8_t - number of created custom characters
-*/
-  uint8_t graphHorizontalChars(uint8_t rowPattern);
-
-/*
-  Create custom characters for vertical graphs
+  Create custom characters for graphs from a predefined glyph set
   
   DESCRIPTION:
-  Creates the set of custom characters for displaying vertical graphs.
-  All 8 current custom characters will be overwritten.
-  Particular custom characters are filled with rowPattern from the very
-  bottom pixel line.
+  Creates the set of custom characters for displaying graphs from a table
+  of glyphs stored in program memory.
+  The first "count" current custom characters will be overwritten.
   
   PARAMETERS:
-  uint8_t rowPattern - row pattern of the pixel line
+  const uint8_t *glyphs - PROGMEM table of character row patterns, 
+                          LCD_CHARACTER_VERTICAL_DOTS bytes per glyph
+  uint8_t count         - number of glyphs in the table
 
   RETURN:	uint8_t - number of created custom characters
 */
-  uint8_t graphVerticalChars(uint8_t rowPattern);
+  uint8_t graphChars(const uint8_t *glyphs, uint8_t count);
+#endif
 
   // Private attributes
   uint8_t _Addr;
@@ -298,8 +406,20 @@ private:
   uint8_t _cols;
   uint8_t _rows;
   uint8_t _backlightval;
+  uint8_t _update;               // Nesting level of update transactions
+  uint8_t _updatedisplaycontrol; // Display control sent before transaction
+  uint8_t _updatedisplaymode;    // Entry mode sent before transaction
+  uint8_t _sentbacklightval;     // Backlight last sent to the expander
+#if LCDI2C_UTF8
+  uint8_t _utf8;              // Flag about transcoding UTF-8
+  uint8_t _utf8pending;       // Number of expected continuation bytes
+  uint16_t _utf8code;         // Code point being decoded
+  uint16_t _utf8cgram[8];     // Code points of custom characters
+#endif
+#if LCDI2C_GRAPHS
   uint8_t _graphtype;   // Internal code for graph type
-  uint8_t _graphstate[20];  // Internal last graph column/row state
+  uint8_t _graphstate[LCDI2C_GRAPH_STATE_SIZE];  // Internal last graph column/row state
+#endif
 };
 
 #endif
@@ -0,0 +1,161 @@
+/*
+  NAME:
+  LiquidCrystal_I2C_Queue
+
+  DESCRIPTION:
+  Thread-safe front end of LiquidCrystal_I2C for RTOS tasks, e.g., FreeRTOS
+  tasks on ESP32.
+  - Tasks submit complete positioned text operations into a lock-free
+    multi-producer queue without waiting for the slow I2C bus.
+  - A single drain task writes submitted operations to the LCD in order
+    of their submission.
+  - The queue geometry is set by template parameters, so that each sketch
+    can choose it, e.g., LiquidCrystal_I2C_Queue<32, 16> for 32 operations
+    with texts up to 16 characters.
+  - Library requires <atomic> of the C++ standard library, so that it is
+    not available on AVR.
+
+  LICENSE:
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the MIT License (MIT).
+    
+  CREDENTIALS:
+  Author: Libor Gabaj
+  GitHub: https://github.com/mrkaleArduinoLib/LiquidCrystal_I2C.git
+ */
+#ifndef LIQUIDCRYSTAL_I2C_QUEUE_H
+#define LIQUIDCRYSTAL_I2C_QUEUE_H
+
+// queue is available only with the C++ standard header <atomic>
+#if defined(__has_include)
+  #if __has_include(<atomic>)
+    #define LCDI2C_QUEUE 1
+  #endif
+#endif
+#ifdef LCDI2C_QUEUE
+
+#include <atomic>
+#include "LiquidCrystal_I2C.h"
+
+/*
+  PARAMETERS:
+  Size    - number of queued operations, must be a power of 2
+  TextLen - maximal length of a text of an operation in bytes
+            Longer text is truncated at a UTF-8 character boundary.
+*/
+template <uint8_t Size = 16, uint8_t TextLen = 20>
+class LiquidCrystal_I2C_Queue {
+  static_assert(Size > 0 && (Size & (Size - 1)) == 0, "Queue size must be a power of 2");
+
+public:
+  LiquidCrystal_I2C_Queue(LiquidCrystal_I2C &lcd);
+
+/*
+  Submit text to be displayed at desired cursor position
+  
+  DESCRIPTION:
+  Copies the text into the queue without blocking and without any
+  communication with the LCD, so that it can be called concurrently
+  from any number of tasks.
+  
+  PARAMETERS:
+  uint8_t col      - column of the first character counting from 0
+  uint8_t row      - row of the text counting from 0
+  const char *text - text to be displayed
+                     Limited to TextLen bytes without splitting
+                     a UTF-8 character.
+  
+  RETURN:	boolean flag about success
+          true  - operation has been submitted
+          false - queue is full, operation has been dropped
+*/
+  bool print(uint8_t col, uint8_t row, const char *text);
+
+/*
+  Write all submitted operations to the LCD
+  
+  DESCRIPTION:
+  Writes operations to the LCD in order of their submission. It should be
+  called from one task only, which is the only one communicating with the LCD.
+  The function stops at the first operation, which is still being submitted.
+
+  RETURN:	uint16_t - number of written operations
+*/
+  uint16_t drain();
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> sequence; // Submission ticket of the slot
+    uint8_t col;
+    uint8_t row;
+    char text[TextLen + 1];
+  };
+
+  LiquidCrystal_I2C &_lcd;
+  Slot _slots[Size];
+  std::atomic<uint32_t> _enqueuePos; // Next ticket for producers
+  uint32_t _dequeuePos;              // Next ticket for the drain task
+};
+
+// Every slot is marked free for the ticket equal to its index
+template <uint8_t Size, uint8_t TextLen>
+LiquidCrystal_I2C_Queue<Size, TextLen>::LiquidCrystal_I2C_Queue(LiquidCrystal_I2C &lcd) : _lcd(lcd)
+{
+  for (uint32_t i = 0; i < Size; i++) {
+    _slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  _enqueuePos.store(0, std::memory_order_relaxed);
+  _dequeuePos = 0;
+}
+
+// Submit text to be displayed at desired cursor position
+template <uint8_t Size, uint8_t TextLen>
+bool LiquidCrystal_I2C_Queue<Size, TextLen>::print(uint8_t col, uint8_t row, const char *text) {
+  uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+  Slot *slot;
+  // Claim a ticket, whose slot has been already released by the drain task
+  for (;;) {
+    slot = &_slots[pos & (Size - 1)];
+    int32_t dif = (int32_t) (slot->sequence.load(std::memory_order_acquire) - pos);
+    if (dif == 0) {
+      if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (dif < 0) {
+      return false; // Queue is full
+    } else {
+      pos = _enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  // Fill the slot and publish it to the drain task
+  slot->col = col;
+  slot->row = row;
+  size_t len = 0;
+  while (len < TextLen && text[len]) len++;
+  // Truncated text must not end with a part of a UTF-8 character
+  if (text[len]) {
+    while (len > 0 && (text[len] & 0xC0) == 0x80) len--;
+  }
+  for (size_t i = 0; i < len; i++) slot->text[i] = text[i];
+  slot->text[len] = '\0';
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+// Write all submitted operations to the LCD
+template <uint8_t Size, uint8_t TextLen>
+uint16_t LiquidCrystal_I2C_Queue<Size, TextLen>::drain() {
+  uint16_t count = 0;
+  for (;;) {
+    Slot *slot = &_slots[_dequeuePos & (Size - 1)];
+    if (slot->sequence.load(std::memory_order_acquire) != _dequeuePos + 1) break;
+    _lcd.setCursor(slot->col, slot->row);
+    _lcd.print(slot->text);
+    // Release the slot for the ticket of the next round
+    slot->sequence.store(_dequeuePos + Size, std::memory_order_release);
+    _dequeuePos++;
+    count++;
+  }
+  return count;
+}
+
+#endif
+#endif